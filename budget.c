@@ -1,22 +1,71 @@
 #include <gtk/gtk.h>
+#include <cairo-pdf.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <locale.h>
+#include <errno.h>
 
-typedef enum { INCOME, EXPENSE } TransactionType;
+#include "ledger.h"
+
+Ledger *ledger = NULL; // 目前版本，只在主執行緒中替換
+int selectedTransactionIndex = -1;
+
+// 報表設定
+#define REPORT_MAX_YEAR G_MAXUINT16 // GDate 可表示的最大年份
+#define REPORT_TOP_COUNT 10
+#define REPORT_MIN_ROWS_PER_THREAD 4096 // 資料太少時不值得另開執行緒
+
+// 報表區間
+typedef struct {
+    int year;  // 0 表示所有年度 (每年一列)
+    int month; // 0 表示整年 (每月一列)，否則每日一列
+} ReportScope;
+
+typedef struct {
+    double income;
+    double expense;
+    int count;
+} ReportBucket;
 
 typedef struct {
-    TransactionType type;
     char description[50];
-    float amount;
-    char date[11]; // 格式: YYYY-MM-DD
-} Transaction;
+    double amount;
+} ReportTopEntry;
 
-Transaction *transactions = NULL;
-int transactionCount = 0;
-int selectedTransactionIndex = -1;
+typedef struct {
+    ReportScope scope;
+    int numBuckets;
+    int firstBucket, lastBucket; // 報表列出的期間範圍
+    ReportBucket *buckets;
+    double *running; // 各期結束時的累計結餘
+    double opening; // 報表區間之前的結餘
+    int skippedCount; // 日期無法解析而未列入報表的交易
+    double skippedNet;
+    double totalIncome, totalExpense;
+    int totalCount;
+    int topCount;
+    ReportTopEntry top[REPORT_TOP_COUNT]; // 支出金額最高的描述
+} Report;
+
+// 單一執行緒負責的交易範圍與統計結果
+typedef struct {
+    const Ledger *snapshot;
+    ReportScope scope;
+    int numBuckets;
+    int firstRow, lastRow;
+    ReportBucket *buckets;
+    int usedFirst, usedLast; // 有資料的期間範圍，合併時只需處理這一段
+    double opening;
+    int skippedCount;
+    double skippedNet;
+    GHashTable *expenseByDesc;
+} ReportPartial;
+
+static gint latestSaveVersion = 0;
+static GThreadPool *savePool = NULL;
+static GThreadPool *exportPool = NULL;
 
 GtkWidget *entry_desc, *entry_amount, *entry_date, *combo_type, *text_view;
 GtkWidget *delete_button, *edit_button, *update_button, *cancel_button;
@@ -27,6 +76,7 @@ GtkTextBuffer *buffer;
 GtkWidget *main_window; // 儲存主視窗以便全局訪問
 
 // 函式宣告
+void commitLedger(Ledger *next);
 void addTransaction(GtkWidget *widget, gpointer data);
 void viewTransactions();
 void saveTransactions();
@@ -39,36 +89,57 @@ void cancelEdit(GtkWidget *widget, gpointer data);
 void refreshTreeView();
 void updateTotalBalance();
 gboolean createChart(GtkWidget *widget, cairo_t *cr, gpointer data);
-void populateDataForChart(float *income_data, float *expense_data, int *num_months);
+void populateDataForChart(const Ledger *snapshot, float *income_data, float *expense_data, int *num_months);
 void showChart(GtkWidget *widget, gpointer data);
 gboolean on_treeview_selection_changed(GtkTreeSelection *selection, gpointer data);
 void setButtonStates(gboolean editing);
+void buildReport(const Ledger *snapshot, ReportScope scope, Report *report);
+void freeReport(Report *report);
+gboolean writeReportCsv(const Report *report, const char *path);
+gboolean writeReportPdf(const Report *report, const char *path);
+gboolean exportReport(const Ledger *snapshot, ReportScope scope, const char *path);
+void showReportDialog(GtkWidget *widget, gpointer data);
+int runHeadlessReport(int argc, char *argv[]);
 
-void addTransaction(GtkWidget *widget, gpointer data) {
-    transactionCount++;
-    transactions = realloc(transactions, transactionCount * sizeof(Transaction));
+// 發佈新版本，舊版本由仍持有參考的讀取者自行釋放
+void commitLedger(Ledger *next) {
+    Ledger *old = ledger;
+    ledger = next;
+    ledgerUnref(old);
+}
+
+// 從介面輸入框讀取交易內容
+static void readTransactionFromEntries(Transaction *t) {
+    memset(t, 0, sizeof(Transaction));
+    t->type = gtk_combo_box_get_active(GTK_COMBO_BOX(combo_type));
 
-    transactions[transactionCount - 1].type = gtk_combo_box_get_active(GTK_COMBO_BOX(combo_type));
     const char *desc = gtk_entry_get_text(GTK_ENTRY(entry_desc));
-    strncpy(transactions[transactionCount - 1].description, desc, 50);
-    transactions[transactionCount - 1].description[49] = '\0';
+    strncpy(t->description, desc, 50);
+    t->description[49] = '\0';
+
+    t->amount = atof(gtk_entry_get_text(GTK_ENTRY(entry_amount)));
 
-    transactions[transactionCount - 1].amount = atof(gtk_entry_get_text(GTK_ENTRY(entry_amount)));
-    
     const char *date = gtk_entry_get_text(GTK_ENTRY(entry_date));
-    if (strlen(date) > 0) {
-        strncpy(transactions[transactionCount - 1].date, date, 10);
-        transactions[transactionCount - 1].date[10] = '\0';
-    } else {
+    strncpy(t->date, date, 10);
+    t->date[10] = '\0';
+}
+
+void addTransaction(GtkWidget *widget, gpointer data) {
+    Transaction t;
+    readTransactionFromEntries(&t);
+
+    if (strlen(t.date) == 0) {
         // 如果沒有輸入日期，使用當前日期
         GDateTime *now = g_date_time_new_now_local();
         char *date_str = g_date_time_format(now, "%Y-%m-%d");
-        strncpy(transactions[transactionCount - 1].date, date_str, 10);
-        transactions[transactionCount - 1].date[10] = '\0';
+        strncpy(t.date, date_str, 10);
+        t.date[10] = '\0';
         g_free(date_str);
         g_date_time_unref(now);
     }
 
+    commitLedger(ledgerAppend(ledger, &t));
+
     // 存檔
     saveTransactions();
 
@@ -96,22 +167,25 @@ void viewTransactions() {
     GtkTextIter iter;
     gtk_text_buffer_get_start_iter(buffer, &iter);
     
-    for (int i = 0; i < transactionCount; i++) {
-        gtk_text_buffer_insert(buffer, &iter, transactions[i].type == INCOME ? "[收入] " : "[支出] ", -1);
+    LedgerIter cursor;
+    ledgerIterInit(&cursor, ledger, 0, ledger->count);
+    const Transaction *t;
+    while ((t = ledgerIterNext(&cursor)) != NULL) {
+        gtk_text_buffer_insert(buffer, &iter, t->type == INCOME ? "[收入] " : "[支出] ", -1);
         
         char dateAndDesc[100];
         snprintf(dateAndDesc, sizeof(dateAndDesc), "%s | %s", 
-                transactions[i].date, transactions[i].description);
+                t->date, t->description);
         gtk_text_buffer_insert(buffer, &iter, dateAndDesc, -1);
         
         char amountStr[20];
-        snprintf(amountStr, sizeof(amountStr), " | %.2f\n", transactions[i].amount);
+        snprintf(amountStr, sizeof(amountStr), " | %.2f\n", t->amount);
         gtk_text_buffer_insert(buffer, &iter, amountStr, -1);
         
-        if (transactions[i].type == INCOME)
-            totalIncome += transactions[i].amount;
+        if (t->type == INCOME)
+            totalIncome += t->amount;
         else
-            totalExpense += transactions[i].amount;
+            totalExpense += t->amount;
     }
 
     char summary[100];
@@ -123,27 +197,34 @@ void viewTransactions() {
 void refreshTreeView() {
     gtk_list_store_clear(list_store);
     
-    for (int i = 0; i < transactionCount; i++) {
+    int id = 0;
+    LedgerIter cursor;
+    ledgerIterInit(&cursor, ledger, 0, ledger->count);
+    const Transaction *t;
+    while ((t = ledgerIterNext(&cursor)) != NULL) {
         GtkTreeIter iter;
         gtk_list_store_append(list_store, &iter);
         
         gtk_list_store_set(list_store, &iter,
-                          0, i + 1, // ID
-                          1, transactions[i].date,
-                          2, transactions[i].type == INCOME ? "收入" : "支出",
-                          3, transactions[i].description,
-                          4, transactions[i].amount,
+                          0, ++id, // ID
+                          1, t->date,
+                          2, t->type == INCOME ? "收入" : "支出",
+                          3, t->description,
+                          4, t->amount,
                           -1);
     }
 }
 
 void updateTotalBalance() {
     float totalIncome = 0, totalExpense = 0;
-    for (int i = 0; i < transactionCount; i++) {
-        if (transactions[i].type == INCOME)
-            totalIncome += transactions[i].amount;
+    LedgerIter cursor;
+    ledgerIterInit(&cursor, ledger, 0, ledger->count);
+    const Transaction *t;
+    while ((t = ledgerIterNext(&cursor)) != NULL) {
+        if (t->type == INCOME)
+            totalIncome += t->amount;
         else
-            totalExpense += transactions[i].amount;
+            totalExpense += t->amount;
     }
     
     float balance = totalIncome - totalExpense;
@@ -156,65 +237,92 @@ void updateTotalBalance() {
     GtkWidget *balance_label = g_object_get_data(G_OBJECT(main_window), "balance_label");
     gtk_label_set_markup(GTK_LABEL(balance_label), balance_text);
 }
-void saveTransactions() {
-    FILE *file = fopen("records.txt", "w");
-    if (file == NULL) return;
+// 背景存檔：在存檔執行緒中寫出快照，較新的版本已排入佇列時略過舊版本
+static void saveWorker(gpointer data, gpointer user_data) {
+    Ledger *snapshot = data;
 
-    for (int i = 0; i < transactionCount; i++) {
-        fprintf(file, "%d %s %.2f %s\n", 
-                transactions[i].type, 
-                transactions[i].description, 
-                transactions[i].amount,
-                transactions[i].date);
+    if (snapshot->version == (guint) g_atomic_int_get(&latestSaveVersion)) {
+        FILE *file = fopen("records.txt", "w");
+        if (file != NULL) {
+            LedgerIter cursor;
+            ledgerIterInit(&cursor, snapshot, 0, snapshot->count);
+            const Transaction *t;
+            while ((t = ledgerIterNext(&cursor)) != NULL) {
+                fprintf(file, "%d %s %.2f %s\n", 
+                        t->type, 
+                        t->description, 
+                        t->amount,
+                        t->date);
+            }
+            fclose(file);
+        }
     }
-    
-    fclose(file);
+
+    ledgerUnref(snapshot);
+}
+
+void saveTransactions() {
+    // 單一執行緒的佇列保證存檔依序完成
+    if (savePool == NULL)
+        savePool = g_thread_pool_new(saveWorker, NULL, 1, TRUE, NULL);
+
+    g_atomic_int_set(&latestSaveVersion, (gint) ledger->version);
+    g_thread_pool_push(savePool, ledgerRef(ledger), NULL);
 }
 
 void loadTransactions() {
     FILE *file = fopen("records.txt", "r");
     if (file == NULL) return;
     
-    // 先清空現有的交易記錄
-    transactionCount = 0;
+    Transaction *items = NULL;
+    int count = 0;
     
     char line[200];
     while (fgets(line, sizeof(line), file)) {
-        transactionCount++;
-        transactions = realloc(transactions, transactionCount * sizeof(Transaction));
-        
         int type;
         char desc[50];
         float amount;
         char date[11] = "2025-01-01"; // 預設日期
         
         // 嘗試解析包含日期的格式
-        if (sscanf(line, "%d %s %f %10s", &type, desc, &amount, date) >= 3) {
-            transactions[transactionCount - 1].type = (type == 0) ? INCOME : EXPENSE;
-            strcpy(transactions[transactionCount - 1].description, desc);
-            transactions[transactionCount - 1].amount = amount;
-            strcpy(transactions[transactionCount - 1].date, date);
+        if (sscanf(line, "%d %49s %f %10s", &type, desc, &amount, date) >= 3) {
+            count++;
+            items = realloc(items, count * sizeof(Transaction));
+            items[count - 1].type = (type == 0) ? INCOME : EXPENSE;
+            strcpy(items[count - 1].description, desc);
+            items[count - 1].amount = amount;
+            strcpy(items[count - 1].date, date);
         }
     }
 
     fclose(file);
+
+    // 以讀入的資料取代目前版本
+    commitLedger(ledgerNewFromArray(items, count));
+    free(items);
 }
 
 void freeTransactions() {
-    free(transactions);
+    // 等待背景存檔與報表匯出完成
+    if (savePool != NULL) {
+        g_thread_pool_free(savePool, FALSE, TRUE);
+        savePool = NULL;
+    }
+    if (exportPool != NULL) {
+        g_thread_pool_free(exportPool, FALSE, TRUE);
+        exportPool = NULL;
+    }
+
+    ledgerUnref(ledger);
+    ledger = NULL;
 }
 
 void deleteTransaction(GtkWidget *widget, gpointer data) {
-    if (selectedTransactionIndex < 0 || selectedTransactionIndex >= transactionCount) 
+    if (selectedTransactionIndex < 0 || selectedTransactionIndex >= ledger->count) 
         return;
     
     // 刪除選中的交易
-    for (int i = selectedTransactionIndex; i < transactionCount - 1; i++) {
-        transactions[i] = transactions[i + 1];
-    }
-    
-    transactionCount--;
-    transactions = realloc(transactions, transactionCount * sizeof(Transaction));
+    commitLedger(ledgerRemove(ledger, selectedTransactionIndex));
     
     // 更新UI
     saveTransactions();
@@ -234,39 +342,33 @@ void deleteTransaction(GtkWidget *widget, gpointer data) {
 }
 
 void prepareEditTransaction(GtkWidget *widget, gpointer data) {
-    if (selectedTransactionIndex < 0 || selectedTransactionIndex >= transactionCount) 
+    if (selectedTransactionIndex < 0 || selectedTransactionIndex >= ledger->count) 
         return;
     
+    const Transaction *t = ledgerGet(ledger, selectedTransactionIndex);
+    
     // 填充編輯框
-    gtk_combo_box_set_active(GTK_COMBO_BOX(combo_type), transactions[selectedTransactionIndex].type);
-    gtk_entry_set_text(GTK_ENTRY(entry_desc), transactions[selectedTransactionIndex].description);
+    gtk_combo_box_set_active(GTK_COMBO_BOX(combo_type), t->type);
+    gtk_entry_set_text(GTK_ENTRY(entry_desc), t->description);
     
     char amount_str[20];
-    snprintf(amount_str, sizeof(amount_str), "%.2f", transactions[selectedTransactionIndex].amount);
+    snprintf(amount_str, sizeof(amount_str), "%.2f", t->amount);
     gtk_entry_set_text(GTK_ENTRY(entry_amount), amount_str);
     
-    gtk_entry_set_text(GTK_ENTRY(entry_date), transactions[selectedTransactionIndex].date);
+    gtk_entry_set_text(GTK_ENTRY(entry_date), t->date);
     
     // 更改按鈕狀態
     setButtonStates(TRUE);
 }
 
 void updateTransaction(GtkWidget *widget, gpointer data) {
-    if (selectedTransactionIndex < 0 || selectedTransactionIndex >= transactionCount) 
+    if (selectedTransactionIndex < 0 || selectedTransactionIndex >= ledger->count) 
         return;
     
     // 更新選中的交易
-    transactions[selectedTransactionIndex].type = gtk_combo_box_get_active(GTK_COMBO_BOX(combo_type));
-    
-    const char *desc = gtk_entry_get_text(GTK_ENTRY(entry_desc));
-    strncpy(transactions[selectedTransactionIndex].description, desc, 50);
-    transactions[selectedTransactionIndex].description[49] = '\0';
-    
-    transactions[selectedTransactionIndex].amount = atof(gtk_entry_get_text(GTK_ENTRY(entry_amount)));
-    
-    const char *date = gtk_entry_get_text(GTK_ENTRY(entry_date));
-    strncpy(transactions[selectedTransactionIndex].date, date, 10);
-    transactions[selectedTransactionIndex].date[10] = '\0';
+    Transaction t;
+    readTransactionFromEntries(&t);
+    commitLedger(ledgerReplace(ledger, selectedTransactionIndex, &t));
     
     // 更新UI
     saveTransactions();
@@ -334,23 +436,26 @@ gboolean on_treeview_selection_changed(GtkTreeSelection *selection, gpointer dat
     return FALSE;
 }
 
-void populateDataForChart(float *income_data, float *expense_data, int *num_months) {
+void populateDataForChart(const Ledger *snapshot, float *income_data, float *expense_data, int *num_months) {
     // 初始化數據
     memset(income_data, 0, 12 * sizeof(float));
     memset(expense_data, 0, 12 * sizeof(float));
     *num_months = 0;
     
     // 計算每個月的收入和支出
-    for (int i = 0; i < transactionCount; i++) {
+    LedgerIter cursor;
+    ledgerIterInit(&cursor, snapshot, 0, snapshot->count);
+    const Transaction *t;
+    while ((t = ledgerIterNext(&cursor)) != NULL) {
         int year, month, day;
-        if (sscanf(transactions[i].date, "%d-%d-%d", &year, &month, &day) == 3) {
+        if (sscanf(t->date, "%d-%d-%d", &year, &month, &day) == 3) {
             if (month >= 1 && month <= 12) {
-                if (transactions[i].type == INCOME) {
-                    income_data[month-1] += transactions[i].amount;
+                if (t->type == INCOME) {
+                    income_data[month-1] += t->amount;
                 } else {
-                    expense_data[month-1] += transactions[i].amount;
+                    expense_data[month-1] += t->amount;
                 }
-                
+            
                 if (income_data[month-1] > 0 || expense_data[month-1] > 0) {
                     if (month > *num_months) *num_months = month;
                 }
@@ -364,7 +469,10 @@ gboolean createChart(GtkWidget *widget, cairo_t *cr, gpointer data) {
     float expense_data[12] = {0};
     int num_months = 0;
     
-    populateDataForChart(income_data, expense_data, &num_months);
+    // 繪製期間持有目前版本的快照
+    Ledger *snapshot = ledgerRef(ledger);
+    populateDataForChart(snapshot, income_data, expense_data, &num_months);
+    ledgerUnref(snapshot);
     
     if (num_months == 0) {
         // 沒有數據
@@ -506,10 +614,611 @@ void showChart(GtkWidget *widget, gpointer data) {
     gtk_widget_destroy(dialog);
 }
 
+// 解析 YYYY-MM-DD 日期，固定格式直接讀取數字，其他格式退回 sscanf。
+// 不存在的日期 (例如 2025-02-30) 視為無效
+static gboolean reportParseDate(const char *date, int *year, int *month, int *day) {
+    if (g_ascii_isdigit(date[0]) && g_ascii_isdigit(date[1]) && g_ascii_isdigit(date[2]) &&
+        g_ascii_isdigit(date[3]) && date[4] == '-' && g_ascii_isdigit(date[5]) &&
+        g_ascii_isdigit(date[6]) && date[7] == '-' && g_ascii_isdigit(date[8]) &&
+        g_ascii_isdigit(date[9])) {
+        *year = (date[0] - '0') * 1000 + (date[1] - '0') * 100 + (date[2] - '0') * 10 + (date[3] - '0');
+        *month = (date[5] - '0') * 10 + (date[6] - '0');
+        *day = (date[8] - '0') * 10 + (date[9] - '0');
+    } else if (sscanf(date, "%d-%d-%d", year, month, day) != 3) {
+        return FALSE;
+    }
+
+    if (*year < 1 || *year > G_MAXUINT16 || *month < 1 || *month > 12 || *day < 1 || *day > 31)
+        return FALSE;
+    return g_date_valid_dmy(*day, *month, *year);
+}
+
+// 計算交易所屬的統計期間，日期早於報表區間時 *before 設為 TRUE
+static int reportBucketOf(const ReportScope *scope, int year, int month, int day, gboolean *before) {
+    *before = FALSE;
+
+    if (scope->year == 0) {
+        // 年度報表：每年一列，以年份作為索引
+        return year;
+    }
+
+    if (scope->month == 0) {
+        // 單一年度：每月一列
+        if (year < scope->year)
+            *before = TRUE;
+        return year == scope->year ? month - 1 : -1;
+    }
+
+    // 單一月份：每日一列
+    if (year < scope->year || (year == scope->year && month < scope->month))
+        *before = TRUE;
+    return (year == scope->year && month == scope->month) ? day - 1 : -1;
+}
+
+// map 階段：統計分配到的交易範圍
+static gpointer reportMapWorker(gpointer data) {
+    ReportPartial *partial = data;
+    const Ledger *snapshot = partial->snapshot;
+
+    LedgerIter cursor;
+    ledgerIterInit(&cursor, snapshot, partial->firstRow, partial->lastRow);
+    const Transaction *t;
+    while ((t = ledgerIterNext(&cursor)) != NULL) {
+        int year, month, day;
+        gboolean before;
+
+        if (!reportParseDate(t->date, &year, &month, &day)) {
+            partial->skippedCount++;
+            partial->skippedNet += (t->type == INCOME) ? t->amount : -t->amount;
+            continue;
+        }
+
+        int bucket = reportBucketOf(&partial->scope, year, month, day, &before);
+        if (before) {
+            partial->opening += (t->type == INCOME) ? t->amount : -t->amount;
+            continue;
+        }
+        if (bucket < 0 || bucket >= partial->numBuckets)
+            continue;
+
+        if (bucket < partial->usedFirst)
+            partial->usedFirst = bucket;
+        if (bucket > partial->usedLast)
+            partial->usedLast = bucket;
+
+        ReportBucket *b = &partial->buckets[bucket];
+        b->count++;
+        if (t->type == INCOME) {
+            b->income += t->amount;
+        } else {
+            b->expense += t->amount;
+
+            // 描述字串指向快照內的資料，快照存活期間都有效
+            double *total = g_hash_table_lookup(partial->expenseByDesc, t->description);
+            if (total == NULL) {
+                total = g_new0(double, 1);
+                g_hash_table_insert(partial->expenseByDesc, (gpointer) t->description, total);
+            }
+            *total += t->amount;
+        }
+    }
+
+    return NULL;
+}
+
+static gint compareTopEntries(gconstpointer a, gconstpointer b) {
+    const ReportTopEntry *x = a, *y = b;
+    if (x->amount != y->amount)
+        return x->amount < y->amount ? 1 : -1;
+    return strcmp(x->description, y->description);
+}
+
+// 依快照產生報表：將交易分段在所有核心上平行統計，再合併結果
+void buildReport(const Ledger *snapshot, ReportScope scope, Report *report) {
+    memset(report, 0, sizeof(Report));
+    report->scope = scope;
+
+    if (scope.year == 0)
+        report->numBuckets = REPORT_MAX_YEAR + 1;
+    else if (scope.month == 0)
+        report->numBuckets = 12;
+    else
+        report->numBuckets = g_date_get_days_in_month(scope.month, scope.year);
+
+    int numThreads = MIN((int) g_get_num_processors(), snapshot->count / REPORT_MIN_ROWS_PER_THREAD);
+    if (numThreads < 1)
+        numThreads = 1;
+
+    report->buckets = g_new0(ReportBucket, report->numBuckets);
+    report->running = g_new0(double, report->numBuckets);
+
+    ReportPartial *partials = g_new0(ReportPartial, numThreads);
+    GThread **threads = g_new0(GThread *, numThreads);
+
+    for (int i = 0; i < numThreads; i++) {
+        partials[i].snapshot = snapshot;
+        partials[i].scope = scope;
+        partials[i].numBuckets = report->numBuckets;
+        partials[i].buckets = g_new0(ReportBucket, report->numBuckets);
+        partials[i].usedFirst = report->numBuckets;
+        partials[i].usedLast = -1;
+        partials[i].firstRow = (int) ((gint64) snapshot->count * i / numThreads);
+        partials[i].lastRow = (int) ((gint64) snapshot->count * (i + 1) / numThreads);
+        partials[i].expenseByDesc = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+    }
+
+    // 第一份工作由目前的執行緒處理
+    for (int i = 1; i < numThreads; i++)
+        threads[i] = g_thread_new("report", reportMapWorker, &partials[i]);
+    reportMapWorker(&partials[0]);
+
+    // reduce 階段：合併各執行緒的統計
+    GHashTable *expenseByDesc = partials[0].expenseByDesc;
+    int usedFirst = report->numBuckets, usedLast = -1;
+    for (int i = 0; i < numThreads; i++) {
+        if (i > 0) {
+            g_thread_join(threads[i]);
+
+            GHashTableIter iter;
+            gpointer key, value;
+            g_hash_table_iter_init(&iter, partials[i].expenseByDesc);
+            while (g_hash_table_iter_next(&iter, &key, &value)) {
+                double *total = g_hash_table_lookup(expenseByDesc, key);
+                if (total == NULL) {
+                    g_hash_table_iter_steal(&iter);
+                    g_hash_table_insert(expenseByDesc, key, value);
+                } else {
+                    *total += *(double *) value;
+                }
+            }
+            g_hash_table_destroy(partials[i].expenseByDesc);
+        }
+
+        report->opening += partials[i].opening;
+        report->skippedCount += partials[i].skippedCount;
+        report->skippedNet += partials[i].skippedNet;
+        for (int b = partials[i].usedFirst; b <= partials[i].usedLast; b++) {
+            report->buckets[b].income += partials[i].buckets[b].income;
+            report->buckets[b].expense += partials[i].buckets[b].expense;
+            report->buckets[b].count += partials[i].buckets[b].count;
+        }
+        usedFirst = MIN(usedFirst, partials[i].usedFirst);
+        usedLast = MAX(usedLast, partials[i].usedLast);
+        g_free(partials[i].buckets);
+    }
+
+    // 年度報表只列出最早到最晚有資料的年份
+    report->firstBucket = 0;
+    report->lastBucket = report->numBuckets - 1;
+    if (scope.year == 0) {
+        report->firstBucket = usedFirst <= usedLast ? usedFirst : 0;
+        report->lastBucket = usedLast;
+    }
+
+    // 合計與累計結餘
+    double balance = report->opening;
+    for (int b = report->firstBucket; b <= report->lastBucket; b++) {
+        report->totalIncome += report->buckets[b].income;
+        report->totalExpense += report->buckets[b].expense;
+        report->totalCount += report->buckets[b].count;
+        balance += report->buckets[b].income - report->buckets[b].expense;
+        report->running[b] = balance;
+    }
+
+    // 取出支出金額最高的描述
+    int numEntries = g_hash_table_size(expenseByDesc);
+    ReportTopEntry *entries = g_new(ReportTopEntry, MAX(numEntries, 1));
+    GHashTableIter iter;
+    gpointer key, value;
+    int n = 0;
+    g_hash_table_iter_init(&iter, expenseByDesc);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        g_strlcpy(entries[n].description, key, sizeof(entries[n].description));
+        entries[n].amount = *(double *) value;
+        n++;
+    }
+    qsort(entries, n, sizeof(ReportTopEntry), compareTopEntries);
+    report->topCount = MIN(n, REPORT_TOP_COUNT);
+    memcpy(report->top, entries, report->topCount * sizeof(ReportTopEntry));
+
+    g_free(entries);
+    g_hash_table_destroy(expenseByDesc);
+    g_free(threads);
+    g_free(partials);
+}
+
+void freeReport(Report *report) {
+    g_free(report->buckets);
+    g_free(report->running);
+}
+
+static void reportTitle(const Report *report, char *buf, size_t size) {
+    if (report->scope.year == 0)
+        snprintf(buf, size, "年度收支報表");
+    else if (report->scope.month == 0)
+        snprintf(buf, size, "%d 年收支報表", report->scope.year);
+    else
+        snprintf(buf, size, "%d 年 %d 月收支報表", report->scope.year, report->scope.month);
+}
+
+static void reportPeriodLabel(const Report *report, int bucket, char *buf, size_t size) {
+    if (report->scope.year == 0)
+        snprintf(buf, size, "%d", bucket);
+    else if (report->scope.month == 0)
+        snprintf(buf, size, "%04d-%02d", report->scope.year, bucket + 1);
+    else
+        snprintf(buf, size, "%04d-%02d-%02d", report->scope.year, report->scope.month, bucket + 1);
+}
+
+static int reportPeriodCount(const Report *report) {
+    return MAX(report->lastBucket - report->firstBucket + 1, 1);
+}
+
+// CSV 欄位含逗號或引號時加上引號
+static void writeCsvField(FILE *file, const char *field) {
+    if (strpbrk(field, ",\"\n") == NULL) {
+        fputs(field, file);
+        return;
+    }
+
+    fputc('"', file);
+    for (const char *p = field; *p; p++) {
+        if (*p == '"')
+            fputc('"', file);
+        fputc(*p, file);
+    }
+    fputc('"', file);
+}
+
+// 以逗號開頭輸出金額；不受 setlocale() 影響，小數點固定為 '.'，避免與欄位分隔符號衝突
+static void writeCsvAmount(FILE *file, double amount) {
+    char buf[G_ASCII_DTOSTR_BUF_SIZE];
+    fputc(',', file);
+    fputs(g_ascii_formatd(buf, sizeof(buf), "%.2f", amount), file);
+}
+
+gboolean writeReportCsv(const Report *report, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return FALSE;
+
+    char title[100];
+    reportTitle(report, title, sizeof(title));
+    fprintf(file, "%s\n", title);
+    fputs("期初結餘", file);
+    writeCsvAmount(file, report->opening);
+    fprintf(file, "\n日期無效未列入筆數,%d\n", report->skippedCount);
+    fputs("日期無效未列入淨額", file);
+    writeCsvAmount(file, report->skippedNet);
+    fputs("\n\n", file);
+
+    fprintf(file, "期間,收入,支出,淨額,累計結餘,筆數\n");
+    for (int b = report->firstBucket; b <= report->lastBucket; b++) {
+        const ReportBucket *bucket = &report->buckets[b];
+        char label[20];
+        reportPeriodLabel(report, b, label, sizeof(label));
+        fputs(label, file);
+        writeCsvAmount(file, bucket->income);
+        writeCsvAmount(file, bucket->expense);
+        writeCsvAmount(file, bucket->income - bucket->expense);
+        writeCsvAmount(file, report->running[b]);
+        fprintf(file, ",%d\n", bucket->count);
+    }
+
+    int periods = reportPeriodCount(report);
+    fputs("合計", file);
+    writeCsvAmount(file, report->totalIncome);
+    writeCsvAmount(file, report->totalExpense);
+    writeCsvAmount(file, report->totalIncome - report->totalExpense);
+    fprintf(file, ",,%d\n", report->totalCount);
+
+    fputs("平均", file);
+    writeCsvAmount(file, report->totalIncome / periods);
+    writeCsvAmount(file, report->totalExpense / periods);
+    writeCsvAmount(file, (report->totalIncome - report->totalExpense) / periods);
+    fputs(",,\n", file);
+
+    fprintf(file, "\n主要支出項目\n排名,描述,金額\n");
+    for (int i = 0; i < report->topCount; i++) {
+        fprintf(file, "%d,", i + 1);
+        writeCsvField(file, report->top[i].description);
+        writeCsvAmount(file, report->top[i].amount);
+        fputc('\n', file);
+    }
+
+    return fclose(file) == 0;
+}
+
+// PDF 版面 (A4，單位為點)
+#define PDF_PAGE_WIDTH 595.0
+#define PDF_PAGE_HEIGHT 842.0
+#define PDF_MARGIN 50.0
+#define PDF_LINE_HEIGHT 16.0
+
+static void pdfNextLine(cairo_t *cr, double *y) {
+    *y += PDF_LINE_HEIGHT;
+    if (*y > PDF_PAGE_HEIGHT - PDF_MARGIN) {
+        cairo_show_page(cr);
+        *y = PDF_MARGIN + PDF_LINE_HEIGHT;
+    }
+}
+
+// 依欄位位置輸出一列文字
+static void pdfRow(cairo_t *cr, double y, const char **cells, int numCells) {
+    const double columns[] = {PDF_MARGIN, 150, 235, 320, 405, 490};
+    for (int i = 0; i < numCells; i++) {
+        cairo_move_to(cr, columns[i], y);
+        cairo_show_text(cr, cells[i]);
+    }
+}
+
+gboolean writeReportPdf(const Report *report, const char *path) {
+    cairo_surface_t *surface = cairo_pdf_surface_create(path, PDF_PAGE_WIDTH, PDF_PAGE_HEIGHT);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return FALSE;
+    }
+
+    cairo_t *cr = cairo_create(surface);
+    cairo_set_source_rgb(cr, 0, 0, 0);
+
+    // 標題
+    char title[100];
+    reportTitle(report, title, sizeof(title));
+    cairo_select_font_face(cr, "Noto Sans CJK TC", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 18);
+    double y = PDF_MARGIN + 18;
+    cairo_move_to(cr, PDF_MARGIN, y);
+    cairo_show_text(cr, title);
+
+    cairo_select_font_face(cr, "Noto Sans CJK TC", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, 11);
+
+    char text[100];
+    snprintf(text, sizeof(text), "期初結餘: %.2f", report->opening);
+    y += PDF_LINE_HEIGHT * 2;
+    cairo_move_to(cr, PDF_MARGIN, y);
+    cairo_show_text(cr, text);
+
+    snprintf(text, sizeof(text), "日期無效未列入: %d 筆 (淨額 %.2f)", report->skippedCount, report->skippedNet);
+    pdfNextLine(cr, &y);
+    cairo_move_to(cr, PDF_MARGIN, y);
+    cairo_show_text(cr, text);
+
+    // 各期明細
+    const char *header[] = {"期間", "收入", "支出", "淨額", "累計結餘", "筆數"};
+    pdfNextLine(cr, &y);
+    pdfNextLine(cr, &y);
+    pdfRow(cr, y, header, 6);
+
+    char cells[6][32];
+    const char *row[] = {cells[0], cells[1], cells[2], cells[3], cells[4], cells[5]};
+    for (int b = report->firstBucket; b <= report->lastBucket; b++) {
+        const ReportBucket *bucket = &report->buckets[b];
+        reportPeriodLabel(report, b, cells[0], sizeof(cells[0]));
+        snprintf(cells[1], sizeof(cells[1]), "%.2f", bucket->income);
+        snprintf(cells[2], sizeof(cells[2]), "%.2f", bucket->expense);
+        snprintf(cells[3], sizeof(cells[3]), "%.2f", bucket->income - bucket->expense);
+        snprintf(cells[4], sizeof(cells[4]), "%.2f", report->running[b]);
+        snprintf(cells[5], sizeof(cells[5]), "%d", bucket->count);
+        pdfNextLine(cr, &y);
+        pdfRow(cr, y, row, 6);
+    }
+
+    // 合計與平均
+    int periods = reportPeriodCount(report);
+    snprintf(cells[0], sizeof(cells[0]), "合計");
+    snprintf(cells[1], sizeof(cells[1]), "%.2f", report->totalIncome);
+    snprintf(cells[2], sizeof(cells[2]), "%.2f", report->totalExpense);
+    snprintf(cells[3], sizeof(cells[3]), "%.2f", report->totalIncome - report->totalExpense);
+    cells[4][0] = '\0';
+    snprintf(cells[5], sizeof(cells[5]), "%d", report->totalCount);
+    pdfNextLine(cr, &y);
+    pdfNextLine(cr, &y);
+    pdfRow(cr, y, row, 6);
+
+    snprintf(cells[0], sizeof(cells[0]), "平均");
+    snprintf(cells[1], sizeof(cells[1]), "%.2f", report->totalIncome / periods);
+    snprintf(cells[2], sizeof(cells[2]), "%.2f", report->totalExpense / periods);
+    snprintf(cells[3], sizeof(cells[3]), "%.2f", (report->totalIncome - report->totalExpense) / periods);
+    pdfNextLine(cr, &y);
+    pdfRow(cr, y, row, 4);
+
+    // 主要支出項目
+    pdfNextLine(cr, &y);
+    pdfNextLine(cr, &y);
+    cairo_move_to(cr, PDF_MARGIN, y);
+    cairo_show_text(cr, "主要支出項目");
+    for (int i = 0; i < report->topCount; i++) {
+        snprintf(text, sizeof(text), "%2d. %s  %.2f", i + 1, report->top[i].description, report->top[i].amount);
+        pdfNextLine(cr, &y);
+        cairo_move_to(cr, PDF_MARGIN, y);
+        cairo_show_text(cr, text);
+    }
+
+    cairo_show_page(cr);
+    cairo_destroy(cr);
+    cairo_surface_finish(surface);
+    gboolean ok = cairo_surface_status(surface) == CAIRO_STATUS_SUCCESS;
+    cairo_surface_destroy(surface);
+    return ok;
+}
+
+// 依副檔名輸出 CSV 或 PDF
+gboolean exportReport(const Ledger *snapshot, ReportScope scope, const char *path) {
+    Report *report = g_new(Report, 1);
+    buildReport(snapshot, scope, report);
+
+    gboolean ok = g_str_has_suffix(path, ".pdf") ? writeReportPdf(report, path)
+                                                  : writeReportCsv(report, path);
+    freeReport(report);
+    g_free(report);
+    return ok;
+}
+
+// 背景匯出報表的工作內容
+typedef struct {
+    Ledger *snapshot;
+    ReportScope scope;
+    char *path;
+    gboolean ok;
+    gint64 elapsed;
+} ReportJob;
+
+static void showReportMessage(GtkMessageType type, const char *message) {
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(main_window),
+                                               GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                               type,
+                                               GTK_BUTTONS_CLOSE,
+                                               "%s", message);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
+// 匯出完成後回到主執行緒顯示結果
+static gboolean reportJobDone(gpointer data) {
+    ReportJob *job = data;
+
+    char message[300];
+    if (job->ok)
+        snprintf(message, sizeof(message), "報表已匯出至 %s (%.3f 秒)", job->path, job->elapsed / 1000000.0);
+    else
+        snprintf(message, sizeof(message), "無法寫入 %s", job->path);
+    showReportMessage(job->ok ? GTK_MESSAGE_INFO : GTK_MESSAGE_ERROR, message);
+
+    g_free(job->path);
+    g_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+static void reportJobWorker(gpointer data, gpointer user_data) {
+    ReportJob *job = data;
+
+    gint64 start = g_get_monotonic_time();
+    job->ok = exportReport(job->snapshot, job->scope, job->path);
+    job->elapsed = g_get_monotonic_time() - start;
+
+    ledgerUnref(job->snapshot);
+    job->snapshot = NULL;
+    g_idle_add(reportJobDone, job);
+}
+
+void showReportDialog(GtkWidget *widget, gpointer data) {
+    GtkWidget *dialog = gtk_file_chooser_dialog_new("匯出報表",
+                                                    GTK_WINDOW(data),
+                                                    GTK_FILE_CHOOSER_ACTION_SAVE,
+                                                    "取消", GTK_RESPONSE_CANCEL,
+                                                    "匯出", GTK_RESPONSE_ACCEPT,
+                                                    NULL);
+    gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(dialog), TRUE);
+    gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog), "report.pdf");
+
+    // 報表區間：年份 0 表示所有年度，月份 0 表示整年
+    GDateTime *now = g_date_time_new_now_local();
+    GtkWidget *scope_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    GtkWidget *year_spin = gtk_spin_button_new_with_range(0, REPORT_MAX_YEAR, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(year_spin), g_date_time_get_year(now));
+    GtkWidget *month_spin = gtk_spin_button_new_with_range(0, 12, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(month_spin), 0);
+    g_date_time_unref(now);
+
+    gtk_box_pack_start(GTK_BOX(scope_box), gtk_label_new("年份 (0 = 全部):"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(scope_box), year_spin, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(scope_box), gtk_label_new("月份 (0 = 整年):"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(scope_box), month_spin, FALSE, FALSE, 0);
+    gtk_widget_show_all(scope_box);
+    gtk_file_chooser_set_extra_widget(GTK_FILE_CHOOSER(dialog), scope_box);
+
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) != GTK_RESPONSE_ACCEPT) {
+        gtk_widget_destroy(dialog);
+        return;
+    }
+
+    // 非本機檔案 (例如遠端 URI) 沒有路徑
+    char *path = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+    if (path == NULL) {
+        gtk_widget_destroy(dialog);
+        showReportMessage(GTK_MESSAGE_ERROR, "只能匯出至本機檔案");
+        return;
+    }
+
+    ReportJob *job = g_new0(ReportJob, 1);
+    job->snapshot = ledgerRef(ledger);
+    job->scope.year = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(year_spin));
+    job->scope.month = job->scope.year == 0 ? 0 : gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(month_spin));
+    job->path = path;
+    gtk_widget_destroy(dialog);
+
+    // 在背景執行緒產生報表，介面可繼續編輯；單一執行緒的佇列讓匯出依序完成，結束程式前會等待
+    if (exportPool == NULL)
+        exportPool = g_thread_pool_new(reportJobWorker, NULL, 1, TRUE, NULL);
+    g_thread_pool_push(exportPool, job, NULL);
+}
+
+// 解析介於 min 與 max 之間的整數參數，整個字串都必須是數字
+static gboolean parseReportArgument(const char *text, int min, int max, int *value) {
+    char *end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || parsed < min || parsed > max)
+        return FALSE;
+
+    *value = (int) parsed;
+    return TRUE;
+}
+
+static int reportUsage(const char *program) {
+    fprintf(stderr, "用法: %s --report <檔案.csv|檔案.pdf> [年份 (0 = 全部)] [月份 (0 = 整年)]\n", program);
+    return 1;
+}
+
+// 不開啟視窗直接匯出報表: budget_tracker --report <檔案> [年份] [月份]
+int runHeadlessReport(int argc, char *argv[]) {
+    ReportScope scope = {0, 0};
+
+    if (argc < 3 || argc > 5 || argv[2][0] == '\0')
+        return reportUsage(argv[0]);
+
+    if (argc > 3 && !parseReportArgument(argv[3], 0, REPORT_MAX_YEAR, &scope.year)) {
+        fprintf(stderr, "無效的年份: %s\n", argv[3]);
+        return reportUsage(argv[0]);
+    }
+
+    if (argc > 4 && !parseReportArgument(argv[4], 0, 12, &scope.month)) {
+        fprintf(stderr, "無效的月份: %s\n", argv[4]);
+        return reportUsage(argv[0]);
+    }
+
+    if (scope.year == 0 && scope.month != 0) {
+        fprintf(stderr, "指定月份時必須同時指定年份\n");
+        return reportUsage(argv[0]);
+    }
+
+    ledger = ledgerNew();
+    loadTransactions();
+
+    gint64 start = g_get_monotonic_time();
+    gboolean ok = exportReport(ledger, scope, argv[2]);
+    gint64 elapsed = g_get_monotonic_time() - start;
+
+    if (!ok) {
+        fprintf(stderr, "無法寫入 %s\n", argv[2]);
+    } else {
+        printf("報表已匯出至 %s (%d 筆交易, %.3f 秒)\n", argv[2], ledger->count, elapsed / 1000000.0);
+    }
+
+    freeTransactions();
+    return ok ? 0 : 1;
+}
+
 int main(int argc, char *argv[]) {
     setlocale(LC_ALL, "");
+
+    if (argc >= 2 && strcmp(argv[1], "--report") == 0)
+        return runHeadlessReport(argc, argv);
+
     gtk_init(&argc, &argv);
 
+    ledger = ledgerNew();
     loadTransactions();
 
     GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -612,6 +1321,10 @@ int main(int argc, char *argv[]) {
     g_signal_connect(chart_button, "clicked", G_CALLBACK(showChart), window);
     gtk_box_pack_start(GTK_BOX(button_box), chart_button, TRUE, TRUE, 0);
     
+    GtkWidget *report_button = gtk_button_new_with_label("匯出報表");
+    g_signal_connect(report_button, "clicked", G_CALLBACK(showReportDialog), window);
+    gtk_box_pack_start(GTK_BOX(button_box), report_button, TRUE, TRUE, 0);
+    
     // 下方表格和總覽區域
     GtkWidget *paned = gtk_paned_new(GTK_ORIENTATION_VERTICAL);
     gtk_box_pack_start(GTK_BOX(main_box), paned, TRUE, TRUE, 0);
@@ -0,0 +1,245 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+// 版本化的交易帳本 (copy-on-write)，只依賴 GLib，可不經 GTK 單獨測試
+
+#include <glib.h>
+#include <string.h>
+
+typedef enum { INCOME, EXPENSE } TransactionType;
+
+typedef struct {
+    TransactionType type;
+    char description[50];
+    float amount;
+    char date[11]; // 格式: YYYY-MM-DD
+} Transaction;
+
+// 每個帳本區塊最多容納的交易筆數
+#define LEDGER_CHUNK_SIZE 256
+
+// 帳本區塊：建立後內容不再修改，可被多個版本共用
+typedef struct {
+    gint refCount;
+    int count;
+    Transaction items[LEDGER_CHUNK_SIZE];
+} LedgerChunk;
+
+// 帳本版本：不可變的快照。修改時只複製受影響的區塊與區塊指標表 (copy-on-write)，
+// 其他執行緒持有參考即可讀取一致的版本，不需要全域鎖
+typedef struct {
+    gint refCount;
+    guint version;
+    int count;
+    int chunkCount;
+    LedgerChunk **chunks;
+    int *offsets; // offsets[c] 為第 c 個區塊第一筆交易的索引
+} Ledger;
+
+// 依序走訪帳本交易的迭代器，呼叫者不需知道區塊結構
+typedef struct {
+    const Ledger *ledger;
+    int chunk;
+    int item;
+    int remaining;
+} LedgerIter;
+
+static gint ledgerVersionCounter = 0;
+
+static LedgerChunk *ledgerChunkNew() {
+    LedgerChunk *chunk = g_new(LedgerChunk, 1);
+    chunk->refCount = 1;
+    chunk->count = 0;
+    return chunk;
+}
+
+static LedgerChunk *ledgerChunkCopy(const LedgerChunk *chunk) {
+    LedgerChunk *copy = ledgerChunkNew();
+    copy->count = chunk->count;
+    memcpy(copy->items, chunk->items, chunk->count * sizeof(Transaction));
+    return copy;
+}
+
+static LedgerChunk *ledgerChunkRef(LedgerChunk *chunk) {
+    g_atomic_int_inc(&chunk->refCount);
+    return chunk;
+}
+
+static void ledgerChunkUnref(LedgerChunk *chunk) {
+    if (g_atomic_int_dec_and_test(&chunk->refCount))
+        g_free(chunk);
+}
+
+// 配置新版本的外殼，區塊指標由呼叫者填入後再呼叫 ledgerFinish()
+static Ledger *ledgerAlloc(int chunkCount) {
+    Ledger *l = g_new(Ledger, 1);
+    l->refCount = 1;
+    l->version = (guint) g_atomic_int_add(&ledgerVersionCounter, 1) + 1;
+    l->count = 0;
+    l->chunkCount = chunkCount;
+    l->chunks = g_new(LedgerChunk *, MAX(chunkCount, 1));
+    l->offsets = g_new(int, MAX(chunkCount, 1));
+    return l;
+}
+
+// 重新計算各區塊的起始索引與總筆數
+static void ledgerFinish(Ledger *l) {
+    int offset = 0;
+    for (int c = 0; c < l->chunkCount; c++) {
+        l->offsets[c] = offset;
+        offset += l->chunks[c]->count;
+    }
+    l->count = offset;
+}
+
+// 以 base 為基礎產生新版本：從第 first 個區塊起的 replaced 個區塊換成 replacement
+// (NULL 表示只移除)。first 等於區塊數且 replaced 為 0 時表示在最後加入，其餘區塊直接共用
+static Ledger *ledgerDerive(const Ledger *base, int first, int replaced, LedgerChunk *replacement) {
+    Ledger *next = ledgerAlloc(base->chunkCount - replaced + (replacement != NULL ? 1 : 0));
+    int c = 0;
+    for (int i = 0; i < first; i++)
+        next->chunks[c++] = ledgerChunkRef(base->chunks[i]);
+    if (replacement != NULL)
+        next->chunks[c++] = replacement;
+    for (int i = first + replaced; i < base->chunkCount; i++)
+        next->chunks[c++] = ledgerChunkRef(base->chunks[i]);
+
+    ledgerFinish(next);
+    return next;
+}
+
+// 二分搜尋交易所在的區塊
+static int ledgerFindChunk(const Ledger *l, int index) {
+    int lo = 0, hi = l->chunkCount - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (l->offsets[mid] <= index)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo;
+}
+
+static Ledger *ledgerNew() {
+    Ledger *l = ledgerAlloc(0);
+    ledgerFinish(l);
+    return l;
+}
+
+static Ledger *ledgerNewFromArray(const Transaction *items, int count) {
+    Ledger *l = ledgerAlloc((count + LEDGER_CHUNK_SIZE - 1) / LEDGER_CHUNK_SIZE);
+    for (int c = 0; c < l->chunkCount; c++) {
+        LedgerChunk *chunk = ledgerChunkNew();
+        chunk->count = MIN(LEDGER_CHUNK_SIZE, count - c * LEDGER_CHUNK_SIZE);
+        memcpy(chunk->items, items + c * LEDGER_CHUNK_SIZE, chunk->count * sizeof(Transaction));
+        l->chunks[c] = chunk;
+    }
+    ledgerFinish(l);
+    return l;
+}
+
+static Ledger *ledgerRef(Ledger *l) {
+    g_atomic_int_inc(&l->refCount);
+    return l;
+}
+
+static void ledgerUnref(Ledger *l) {
+    if (l == NULL || !g_atomic_int_dec_and_test(&l->refCount))
+        return;
+
+    for (int c = 0; c < l->chunkCount; c++)
+        ledgerChunkUnref(l->chunks[c]);
+    g_free(l->chunks);
+    g_free(l->offsets);
+    g_free(l);
+}
+
+static const Transaction *ledgerGet(const Ledger *l, int index) {
+    int c = ledgerFindChunk(l, index);
+    return &l->chunks[c]->items[index - l->offsets[c]];
+}
+
+// 走訪索引 [first, last) 的交易
+static void ledgerIterInit(LedgerIter *iter, const Ledger *l, int first, int last) {
+    iter->ledger = l;
+    iter->chunk = 0;
+    iter->item = 0;
+    iter->remaining = MAX(last - first, 0);
+    if (iter->remaining > 0) {
+        iter->chunk = ledgerFindChunk(l, first);
+        iter->item = first - l->offsets[iter->chunk];
+    }
+}
+
+// 傳回下一筆交易，走訪完畢時傳回 NULL
+static const Transaction *ledgerIterNext(LedgerIter *iter) {
+    if (iter->remaining == 0)
+        return NULL;
+
+    while (iter->item >= iter->ledger->chunks[iter->chunk]->count) {
+        iter->chunk++;
+        iter->item = 0;
+    }
+    iter->remaining--;
+    return &iter->ledger->chunks[iter->chunk]->items[iter->item++];
+}
+
+static Ledger *ledgerAppend(const Ledger *base, const Transaction *t) {
+    int last = base->chunkCount - 1;
+    if (last >= 0 && base->chunks[last]->count < LEDGER_CHUNK_SIZE) {
+        LedgerChunk *chunk = ledgerChunkCopy(base->chunks[last]);
+        chunk->items[chunk->count++] = *t;
+        return ledgerDerive(base, last, 1, chunk);
+    }
+
+    LedgerChunk *chunk = ledgerChunkNew();
+    chunk->items[chunk->count++] = *t;
+    return ledgerDerive(base, base->chunkCount, 0, chunk);
+}
+
+static Ledger *ledgerReplace(const Ledger *base, int index, const Transaction *t) {
+    int c = ledgerFindChunk(base, index);
+    LedgerChunk *chunk = ledgerChunkCopy(base->chunks[c]);
+    chunk->items[index - base->offsets[c]] = *t;
+    return ledgerDerive(base, c, 1, chunk);
+}
+
+static Ledger *ledgerRemove(const Ledger *base, int index) {
+    int c = ledgerFindChunk(base, index);
+    LedgerChunk *chunk = ledgerChunkCopy(base->chunks[c]);
+    int local = index - base->offsets[c];
+    memmove(&chunk->items[local], &chunk->items[local + 1],
+            (chunk->count - local - 1) * sizeof(Transaction));
+    chunk->count--;
+
+    // 區塊清空時直接從新版本中移除
+    if (chunk->count == 0) {
+        ledgerChunkUnref(chunk);
+        return ledgerDerive(base, c, 1, NULL);
+    }
+
+    // 區塊不到半滿時與放得下的較小相鄰區塊合併，避免刪除後區塊越切越碎
+    if (chunk->count < LEDGER_CHUNK_SIZE / 2) {
+        int neighbour = -1;
+        if (c > 0 && base->chunks[c - 1]->count + chunk->count <= LEDGER_CHUNK_SIZE)
+            neighbour = c - 1;
+        if (c + 1 < base->chunkCount && base->chunks[c + 1]->count + chunk->count <= LEDGER_CHUNK_SIZE &&
+            (neighbour < 0 || base->chunks[c + 1]->count < base->chunks[neighbour]->count))
+            neighbour = c + 1;
+
+        if (neighbour >= 0) {
+            const LedgerChunk *left = neighbour < c ? base->chunks[neighbour] : chunk;
+            const LedgerChunk *right = neighbour < c ? chunk : base->chunks[neighbour];
+            LedgerChunk *merged = ledgerChunkCopy(left);
+            memcpy(&merged->items[merged->count], right->items, right->count * sizeof(Transaction));
+            merged->count += right->count;
+            ledgerChunkUnref(chunk);
+            return ledgerDerive(base, MIN(c, neighbour), 2, merged);
+        }
+    }
+
+    return ledgerDerive(base, c, 1, chunk);
+}
+
+#endif
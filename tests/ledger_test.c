@@ -0,0 +1,151 @@
+// 帳本 (ledger.h) 的獨立測試，不需要 GTK:
+//   gcc -I. tests/ledger_test.c $(pkg-config --cflags --libs glib-2.0) -o ledger_test && ./ledger_test
+
+#include <stdio.h>
+#include "ledger.h"
+
+#define MAX_ROWS 40000
+#define HELD_SNAPSHOTS 8
+
+// 以 amount 作為每筆交易的識別值
+static Transaction makeTransaction(int id) {
+    Transaction t;
+    memset(&t, 0, sizeof(Transaction));
+    t.type = (id % 3 == 0) ? INCOME : EXPENSE;
+    snprintf(t.description, sizeof(t.description), "item%d", id);
+    t.amount = (float) id;
+    strcpy(t.date, "2025-01-01");
+    return t;
+}
+
+// 檢查區塊結構：每個區塊 1 到 LEDGER_CHUNK_SIZE 筆，索引表與總筆數一致
+static void checkInvariants(const Ledger *l) {
+    int offset = 0;
+    for (int c = 0; c < l->chunkCount; c++) {
+        g_assert_cmpint(l->chunks[c]->count, >=, 1);
+        g_assert_cmpint(l->chunks[c]->count, <=, LEDGER_CHUNK_SIZE);
+        g_assert_cmpint(l->offsets[c], ==, offset);
+        offset += l->chunks[c]->count;
+    }
+    g_assert_cmpint(l->count, ==, offset);
+}
+
+// 檢查內容與參考陣列相同，同時測試 ledgerGet 與 LedgerIter
+static void checkContents(const Ledger *l, const int *expected, int count) {
+    g_assert_cmpint(l->count, ==, count);
+
+    LedgerIter cursor;
+    ledgerIterInit(&cursor, l, 0, l->count);
+    for (int i = 0; i < count; i++) {
+        const Transaction *t = ledgerIterNext(&cursor);
+        g_assert_nonnull(t);
+        g_assert_cmpint((int) t->amount, ==, expected[i]);
+        g_assert_cmpint((int) ledgerGet(l, i)->amount, ==, expected[i]);
+    }
+    g_assert_null(ledgerIterNext(&cursor));
+}
+
+static void testRandomEdits(void) {
+    GRand *rand = g_rand_new_with_seed(20261019);
+    int *expected = g_new(int, MAX_ROWS);
+    int count = 0, nextId = 0;
+
+    // 保留的舊版本與當時的內容，之後的修改不能影響它們
+    Ledger *held[HELD_SNAPSHOTS] = {NULL};
+    int *heldExpected[HELD_SNAPSHOTS] = {NULL};
+    int heldCount[HELD_SNAPSHOTS] = {0};
+
+    Ledger *l = ledgerNew();
+    for (int i = 0; i < 20000; i++) {
+        Transaction t = makeTransaction(nextId);
+        Ledger *next = ledgerAppend(l, &t);
+        ledgerUnref(l);
+        l = next;
+        expected[count++] = nextId++;
+    }
+    checkInvariants(l);
+    checkContents(l, expected, count);
+
+    for (int step = 0; step < 60000; step++) {
+        Ledger *next;
+        int op = g_rand_int_range(rand, 0, 10);
+
+        if (op < 6 && count > 1) {
+            int index = g_rand_int_range(rand, 0, count);
+            next = ledgerRemove(l, index);
+            memmove(&expected[index], &expected[index + 1], (count - index - 1) * sizeof(int));
+            count--;
+        } else if (op < 9 && count < MAX_ROWS) {
+            Transaction t = makeTransaction(nextId);
+            next = ledgerAppend(l, &t);
+            expected[count++] = nextId++;
+        } else {
+            int index = g_rand_int_range(rand, 0, count);
+            Transaction t = makeTransaction(nextId);
+            next = ledgerReplace(l, index, &t);
+            expected[index] = nextId++;
+        }
+
+        if (step % 5000 == 0) {
+            int slot = (step / 5000) % HELD_SNAPSHOTS;
+            if (held[slot] != NULL) {
+                checkContents(held[slot], heldExpected[slot], heldCount[slot]);
+                ledgerUnref(held[slot]);
+                g_free(heldExpected[slot]);
+            }
+            held[slot] = ledgerRef(next);
+            heldExpected[slot] = g_memdup2(expected, count * sizeof(int));
+            heldCount[slot] = count;
+        }
+
+        ledgerUnref(l);
+        l = next;
+        g_assert_cmpuint(l->version, >, 0);
+        checkInvariants(l);
+
+        // 刪除後會合併不到半滿的區塊，區塊數不應退化成接近筆數
+        g_assert_cmpint(l->chunkCount, <=, 3 * count / LEDGER_CHUNK_SIZE + 3);
+    }
+    checkContents(l, expected, count);
+
+    for (int slot = 0; slot < HELD_SNAPSHOTS; slot++) {
+        if (held[slot] == NULL)
+            continue;
+        checkInvariants(held[slot]);
+        checkContents(held[slot], heldExpected[slot], heldCount[slot]);
+        ledgerUnref(held[slot]);
+        g_free(heldExpected[slot]);
+    }
+
+    ledgerUnref(l);
+    g_free(expected);
+    g_rand_free(rand);
+}
+
+static void testIterRanges(void) {
+    Transaction *items = g_new(Transaction, 1000);
+    for (int i = 0; i < 1000; i++)
+        items[i] = makeTransaction(i);
+    Ledger *l = ledgerNewFromArray(items, 1000);
+    checkInvariants(l);
+
+    int ranges[][2] = {{0, 0}, {0, 1000}, {255, 257}, {256, 512}, {999, 1000}, {500, 400}};
+    for (size_t r = 0; r < G_N_ELEMENTS(ranges); r++) {
+        int first = ranges[r][0], last = ranges[r][1];
+        LedgerIter cursor;
+        ledgerIterInit(&cursor, l, first, last);
+        for (int i = first; i < last; i++)
+            g_assert_cmpint((int) ledgerIterNext(&cursor)->amount, ==, i);
+        g_assert_null(ledgerIterNext(&cursor));
+    }
+
+    ledgerUnref(l);
+    g_free(items);
+}
+
+int main(int argc, char *argv[]) {
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/ledger/random-edits", testRandomEdits);
+    g_test_add_func("/ledger/iter-ranges", testIterRanges);
+    return g_test_run();
+}